@@ -0,0 +1,54 @@
+#!/bin/sh
+# Runs every mts scheduling policy on generated inputs and reports
+# mean and tail wait times (ready -> ON) and makespan, in simulated seconds.
+#
+# The aging bound only means something relative to how long trains wait, so
+# aging runs once per factor in AGING, with -a set to that multiple of the
+# default policy's mean wait on the same workload.
+#
+# Environment: TRAINS (per workload), SEED, UNIT (usec per tenth of a second),
+# AGING (aging bound factors)
+
+TRAINS=${TRAINS:-200}
+SEED=${SEED:-1}
+UNIT=${UNIT:-1000}
+AGING=${AGING:-"0.5 1 1.5"}
+
+set -e
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+
+# name and gen options of each workload
+workloads="balanced:-e 50 -H 50
+east-heavy:-e 80 -H 50
+high-heavy:-e 50 -H 80
+burst:-e 50 -H 50 -l 1:5
+long-cross:-e 50 -H 50 -c 1:30"
+
+# run <workload> <label> <mts options...>: prints one result row and leaves
+# the mean wait in $tmp/mean
+run() {
+    name=$1
+    label=$2
+    shift 2
+    ./mts "$@" -u "$UNIT" -m "$tmp/metrics.json" "$tmp/$name.txt" > /dev/null
+    sed -n 's/.*"makespan":\([0-9.]*\).*"all":{"count":[0-9]*,"mean":\([0-9.]*\),"p50":\([0-9.]*\),"p90":[0-9.]*,"p99":\([0-9.]*\),"max":\([0-9.]*\).*/\2 \3 \4 \5 \1/p' \
+        "$tmp/metrics.json" > "$tmp/row"
+    read -r mean p50 p99 max makespan < "$tmp/row"
+    printf "%-11s %-13s %9.3f %9.3f %9.3f %9.3f %9.3f\n" \
+        "$name" "$label" "$mean" "$p50" "$p99" "$max" "$makespan"
+    echo "$mean" > "$tmp/mean"
+}
+
+printf "%-11s %-13s %9s %9s %9s %9s %9s\n" workload policy mean p50 p99 max makespan
+echo "$workloads" | while IFS=: read -r name opts; do
+    # shellcheck disable=SC2086
+    ./gen -n "$TRAINS" -s "$SEED" -c 1:10 $opts > "$tmp/$name.txt"
+    run "$name" default -p default
+    default_mean=$(cat "$tmp/mean")
+    run "$name" scf -p scf
+    for factor in $AGING; do
+        bound=$(awk "BEGIN { printf \"%.1f\", $default_mean * $factor }")
+        run "$name" "aging@$bound" -p aging -a "$bound"
+    done
+done
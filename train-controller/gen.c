@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <limits.h>
+
+// Generates a random mts input file on stdout, one "<dir> <load> <cross>" line
+// per train. A lowercase direction is low priority, uppercase is high.
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n trains] [-e east_pct] [-H high_pct] "
+            "[-l min:max load] [-c min:max cross] [-s seed]\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+// Parses "min:max" (or a single value) into a range of tenths of a second.
+void parse_range(const char *arg, int *min, int *max, const char *prog) {
+    int used = 0;
+    if (sscanf(arg, "%d:%d%n", min, max, &used) == 2 && arg[used] == '\0')
+        ;
+    else if (sscanf(arg, "%d%n", min, &used) == 1 && arg[used] == '\0')
+        *max = *min;
+    else
+        usage(prog);
+    if (*min < 1 || *max < *min)
+        usage(prog);
+}
+
+// Parses a whole decimal integer, rejecting empty or trailing junk.
+int parse_int(const char *arg, const char *prog) {
+    char *end;
+    long value = strtol(arg, &end, 10);
+    if (end == arg || *end != '\0' || value < 0 || value > 1000000)
+        usage(prog);
+    return (int)value;
+}
+
+// Parses a seed the same way, allowing the full unsigned int range.
+unsigned int parse_seed(const char *arg, const char *prog) {
+    char *end;
+    unsigned long value = strtoul(arg, &end, 10);
+    if (end == arg || *end != '\0' || arg[0] == '-' || value > UINT_MAX)
+        usage(prog);
+    return (unsigned int)value;
+}
+
+int random_between(int min, int max) {
+    return min + rand() % (max - min + 1);
+}
+
+int main(int argc, char *argv[]) {
+    int count = 75;
+    int east_pct = 50, high_pct = 50;
+    int load_min = 1, load_max = 99;
+    int cross_min = 1, cross_max = 99;
+    unsigned int seed = (unsigned int)time(NULL);
+    int opt;
+    while ((opt = getopt(argc, argv, "n:e:H:l:c:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            count = parse_int(optarg, argv[0]);
+            break;
+        case 'e':
+            east_pct = parse_int(optarg, argv[0]);
+            break;
+        case 'H':
+            high_pct = parse_int(optarg, argv[0]);
+            break;
+        case 'l':
+            parse_range(optarg, &load_min, &load_max, argv[0]);
+            break;
+        case 'c':
+            parse_range(optarg, &cross_min, &cross_max, argv[0]);
+            break;
+        case 's':
+            seed = parse_seed(optarg, argv[0]);
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (optind != argc || east_pct > 100 || high_pct > 100)
+        usage(argv[0]);
+
+    srand(seed);
+    for (int i = 0; i < count; i++) {
+        char dir = (rand() % 100 < east_pct) ? 'e' : 'w';
+        if (rand() % 100 < high_pct)
+            dir = dir - 'a' + 'A'; // uppercase means high priority
+        printf("%c %d %d\n", dir, random_between(load_min, load_max),
+               random_between(cross_min, cross_max));
+    }
+    return 0;
+}
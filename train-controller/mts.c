@@ -5,9 +5,11 @@
 #include <pthread.h>
 #include <sys/time.h>
 #include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <math.h>
 
-#define MAX_TRAINS 75
-#define MAX_WAITING 100
+#define DEFAULT_TIME_UNIT 100000 // usec per tenth of a second of simulated time
 
 typedef struct {
     int id;              
@@ -16,13 +18,22 @@ typedef struct {
     int loading_time;    
     int crossing_time;   
     double ready_time;   
+    double on_time;      // when the train got onto the main track
+    double off_time;     // when the train left the main track
     pthread_cond_t cond; 
     int scheduled;      
 } Train;
 
+// A scheduling policy decides which waiting train gets the main track next.
+typedef struct {
+    const char *name;
+    int direction_limit; // same-direction crossings before opposite trains are forced, 0 = never
+    int (*better)(const Train *t, const Train *candidate); // nonzero if t should go before candidate
+} Policy;
+
 pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
 pthread_cond_t sched_cond = PTHREAD_COND_INITIALIZER;
-Train *waiting_list[MAX_WAITING];
+Train **waiting_list;
 int waiting_count = 0;
 int finished_count = 0;
 int total_trains = 0;
@@ -34,13 +45,32 @@ char last_direction = '\0';
 int consecutive_count = 0;  
 // consecutive trains that crossed in same direction
 struct timeval start_time;   // simulation start time
+int time_unit = DEFAULT_TIME_UNIT; // usec slept per tenth of simulated time
+double aging_bound = 5.0;    // simulated seconds before the aging policy promotes a train
+double decision_time = 0;    // simulated time of the scheduling decision in progress
 
-// this function rounds elapsed time to the nearest 10th of a sec.
-void get_sim_time_str(char *buffer, size_t buf_size) {
+// scheduling metrics
+pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER; // signalled when the last train is off
+FILE *metrics_fp = NULL;        // where the JSON metrics report goes, NULL if disabled
+double report_interval = 0;     // simulated seconds between periodic reports, 0 for none
+int direction_switches = 0;     // times the track changed direction
+int starvation_activations = 0; // times the policy direction limit filtered candidates, 0 under aging
+double busy_time = 0;           // total time the main track was occupied by finished crossings
+Train *on_track = NULL;         // train currently crossing, NULL if the track is free
+double *decision_latency = NULL; // scheduler decision latency per dispatch, in usec
+int decision_count = 0;
+
+// this returns the simulated seconds elapsed since the simulation started.
+double get_elapsed_time() {
     struct timeval tv;
     gettimeofday(&tv, NULL);
-    double elapsed = (tv.tv_sec - start_time.tv_sec) +
-                     (tv.tv_usec - start_time.tv_usec) / 1000000.0;
+    double real = (tv.tv_sec - start_time.tv_sec) +
+                  (tv.tv_usec - start_time.tv_usec) / 1000000.0;
+    return real * DEFAULT_TIME_UNIT / time_unit;
+}
+
+// this function rounds elapsed time to the nearest 10th of a sec.
+void format_sim_time(double elapsed, char *buffer, size_t buf_size) {
     int total_tenths = (int)(elapsed * 10 + 0.5); // rounding to nearest 10th
     int hours = total_tenths / 36000;
     int minutes = (total_tenths % 36000) / 600;
@@ -61,11 +91,71 @@ void remove_train_from_waiting(Train *t) {
     }
 }
 
+// Returns nonzero if t became ready before other (ties broken by id).
+int ready_earlier(const Train *t, const Train *other) {
+    return t->ready_time < other->ready_time ||
+           (t->ready_time == other->ready_time && t->id < other->id);
+}
+
+// Default rules: higher priority first, then the direction opposite to the
+// last crossing (West if nothing crossed yet), then whoever was ready first.
+int default_better(const Train *t, const Train *candidate) {
+    if (t->priority != candidate->priority)
+        return t->priority > candidate->priority;
+    if (t->direction == candidate->direction)
+        return ready_earlier(t, candidate);
+    if (last_direction == '\0')
+        return t->direction == 'W';
+    return candidate->direction == last_direction;
+}
+
+// Shortest crossing first within a priority class, then whoever was ready first.
+int scf_better(const Train *t, const Train *candidate) {
+    if (t->priority != candidate->priority)
+        return t->priority > candidate->priority;
+    if (t->crossing_time != candidate->crossing_time)
+        return t->crossing_time < candidate->crossing_time;
+    return ready_earlier(t, candidate);
+}
+
+// Default rules, except trains that have waited at least aging_bound go first,
+// oldest first, regardless of priority or direction.
+int aging_better(const Train *t, const Train *candidate) {
+    int t_aged = decision_time - t->ready_time >= aging_bound;
+    int c_aged = decision_time - candidate->ready_time >= aging_bound;
+    if (t_aged != c_aged)
+        return t_aged;
+    if (t_aged)
+        return ready_earlier(t, candidate);
+    return default_better(t, candidate);
+}
+
+Policy policies[] = {
+    {"default", 2, default_better},
+    {"scf", 2, scf_better},
+    {"aging", 0, aging_better}, // the aging bound replaces the direction limit
+};
+#define NUM_POLICIES (sizeof(policies) / sizeof(policies[0]))
+Policy *policy = &policies[0];
+
+// Pick the train the policy likes best, skipping trains going last_direction if filter is set.
+Train *pick_candidate(int filter) {
+    Train *candidate = NULL;
+    for (int i = 0; i < waiting_count; i++) {
+        Train *t = waiting_list[i];
+        if (filter && t->direction == last_direction)
+            continue; // skip trains in same direction if opposite exists
+        if (candidate == NULL || policy->better(t, candidate))
+            candidate = t;
+    }
+    return candidate;
+}
+
 // Find the best candidate from waiting list based on scheduling rules.
 Train *find_best_candidate() {
-    Train *candidate = NULL;
     int filter = 0; // if set, consider only trains going opposite of last_direction
-    if (consecutive_count >= 2 && last_direction != '\0') {
+    if (policy->direction_limit > 0 && consecutive_count >= policy->direction_limit &&
+        last_direction != '\0') {
         for (int i = 0; i < waiting_count; i++) {
             if (waiting_list[i]->direction != last_direction) {
                 filter = 1;
@@ -73,76 +163,12 @@ Train *find_best_candidate() {
             }
         }
     }
-    for (int i = 0; i < waiting_count; i++) {
-        Train *t = waiting_list[i];
-        if (filter && t->direction == last_direction)
-            continue; // skip trains in same direction if opposite exists
-        if (candidate == NULL)
-            candidate = t;
-        else {
-            if (t->priority > candidate->priority)
-                candidate = t;
-            else if (t->priority == candidate->priority) {
-                if (t->direction == candidate->direction) {
-                    if (t->ready_time < candidate->ready_time ||
-                       (t->ready_time == candidate->ready_time && t->id < candidate->id))
-                        candidate = t;
-                } else {
-                    if (last_direction == '\0') {
-                        if (t->direction == 'W' && candidate->direction != 'W')
-                            candidate = t;
-                        else if (t->direction == candidate->direction) {
-                            if (t->ready_time < candidate->ready_time ||
-                               (t->ready_time == candidate->ready_time && t->id < candidate->id))
-                                candidate = t;
-                        }
-                    } else {
-                        if (candidate->direction == last_direction && t->direction != last_direction)
-                            candidate = t;
-                        else if (candidate->direction != last_direction && t->direction != last_direction) {
-                            if (t->ready_time < candidate->ready_time ||
-                                (t->ready_time == candidate->ready_time && t->id < candidate->id))
-                                candidate = t;
-                        }
-                    }
-                }
-            }
-        }
-    }
+    if (filter)
+        starvation_activations++;
+    Train *candidate = pick_candidate(filter);
     // If no candidate found due to filtering, choose from all waiting trains.
-    if (candidate == NULL && waiting_count > 0) {
-        candidate = waiting_list[0];
-        for (int i = 1; i < waiting_count; i++) {
-            Train *t = waiting_list[i];
-            if (t->priority > candidate->priority)
-                candidate = t;
-            else if (t->priority == candidate->priority) {
-                if (t->direction == candidate->direction) {
-                    if (t->ready_time < candidate->ready_time ||
-                       (t->ready_time == candidate->ready_time && t->id < candidate->id))
-                        candidate = t;
-                } else {
-                    if (last_direction == '\0') {
-                        if (t->direction == 'W' && candidate->direction != 'W')
-                            candidate = t;
-                        else if (t->direction == candidate->direction) {
-                            if (t->ready_time < candidate->ready_time ||
-                               (t->ready_time == candidate->ready_time && t->id < candidate->id))
-                                candidate = t;
-                        }
-                    } else {
-                        if (candidate->direction == last_direction && t->direction != last_direction)
-                            candidate = t;
-                        else if (candidate->direction != last_direction && t->direction != last_direction) {
-                            if (t->ready_time < candidate->ready_time ||
-                               (t->ready_time == candidate->ready_time && t->id < candidate->id))
-                                candidate = t;
-                        }
-                    }
-                }
-            }
-        }
-    }
+    if (candidate == NULL && waiting_count > 0)
+        candidate = pick_candidate(0);
     return candidate;
 }
 
@@ -158,11 +184,18 @@ void *scheduler_thread(void *arg) {
             }
             pthread_cond_wait(&sched_cond, &mutex);
         }
+        decision_time = get_elapsed_time(); // read by the aging policy, kept out of the latency
+        struct timespec decide_start, decide_end;
+        clock_gettime(CLOCK_MONOTONIC, &decide_start);
         Train *candidate = find_best_candidate();
+        clock_gettime(CLOCK_MONOTONIC, &decide_end);
         if (candidate == NULL) {
             pthread_mutex_unlock(&mutex);
             continue;
         }
+        decision_latency[decision_count++] =
+            (decide_end.tv_sec - decide_start.tv_sec) * 1000000.0 +
+            (decide_end.tv_nsec - decide_start.tv_nsec) / 1000.0;
         remove_train_from_waiting(candidate);
         candidate->scheduled = 1;
         track_in_use = 1;              // reserve track
@@ -177,13 +210,10 @@ void *scheduler_thread(void *arg) {
 // Train thread: this simulates loading, waiting, crossing, and finishing.
 void *train_thread(void *arg) {
     Train *t = (Train *)arg;
-    usleep(t->loading_time * 100000); // simulate loading time
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    t->ready_time = (tv.tv_sec - start_time.tv_sec) +
-                    (tv.tv_usec - start_time.tv_usec) / 1000000.0;
-    char time_str[16];
-    get_sim_time_str(time_str, sizeof(time_str));
+    usleep(t->loading_time * time_unit); // simulate loading time
+    t->ready_time = get_elapsed_time();
+    char time_str[32];
+    format_sim_time(t->ready_time, time_str, sizeof(time_str));
     
     pthread_mutex_lock(&mutex);
     printf("%s Train %2d is ready to go %4s\n", time_str, t->id,
@@ -194,45 +224,290 @@ void *train_thread(void *arg) {
         pthread_cond_wait(&t->cond, &mutex); // waitng until scheduled
     if (last_direction == t->direction)
         consecutive_count++;
-    else
+    else {
+        if (last_direction != '\0')
+            direction_switches++;
         consecutive_count = 1;
+    }
     last_direction = t->direction;
-    get_sim_time_str(time_str, sizeof(time_str));
+    t->on_time = get_elapsed_time();
+    on_track = t;
+    format_sim_time(t->on_time, time_str, sizeof(time_str));
     printf("%s Train %2d is ON the main track going %4s\n", time_str, t->id,
            (t->direction == 'E') ? "East" : "West");
     pthread_mutex_unlock(&mutex);
     
-    usleep(t->crossing_time * 100000); // simulate crossing time
+    usleep(t->crossing_time * time_unit); // simulate crossing time
     
     pthread_mutex_lock(&mutex);
-    get_sim_time_str(time_str, sizeof(time_str));
+    t->off_time = get_elapsed_time();
+    format_sim_time(t->off_time, time_str, sizeof(time_str));
     printf("%s Train %2d is OFF the main track after going %4s\n", time_str, t->id,
            (t->direction == 'E') ? "East" : "West");
+    busy_time += t->off_time - t->on_time;
     finished_count++;
     track_in_use = 0;              // frees the track
+    on_track = NULL;
     pthread_cond_signal(&sched_cond); // notifying scheduler that track is free
+    if (finished_count == total_trains)
+        pthread_cond_signal(&done_cond); // last train, wake the metrics thread
     pthread_mutex_unlock(&mutex);
     
     return NULL;
 }
 
+// upper bounds (seconds) of the wait time histogram buckets, the last bucket is open ended
+static const double wait_buckets[] = {0.1, 0.5, 1, 2, 5, 10, 30, 60};
+#define NUM_WAIT_BUCKETS (sizeof(wait_buckets) / sizeof(wait_buckets[0]))
+
+int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int compare_on_time(const void *a, const void *b) {
+    const Train *x = *(Train *const *)a, *y = *(Train *const *)b;
+    return (x->on_time > y->on_time) - (x->on_time < y->on_time);
+}
+
+// Nearest-rank percentile of an ascending sorted array.
+double percentile(const double *sorted, int n, double pct) {
+    if (n == 0)
+        return 0;
+    int rank = (int)(pct / 100.0 * n + 0.999999);
+    if (rank < 1)
+        rank = 1;
+    return sorted[rank - 1];
+}
+
+// Writes count/mean/percentiles of an array of samples, sorting it in place.
+void write_distribution(FILE *fp, double *samples, int n) {
+    double sum = 0;
+    qsort(samples, n, sizeof(double), compare_double);
+    for (int i = 0; i < n; i++)
+        sum += samples[i];
+    fprintf(fp, "\"count\":%d,\"mean\":%.6f,\"p50\":%.6f,\"p90\":%.6f,"
+            "\"p99\":%.6f,\"max\":%.6f", n, n ? sum / n : 0,
+            percentile(samples, n, 50), percentile(samples, n, 90),
+            percentile(samples, n, 99), n ? samples[n - 1] : 0);
+}
+
+// Writes wait time (ready -> ON) stats for trains matching direction and priority.
+// A direction of '\0' or a priority of -1 matches any train.
+void write_wait_stats(FILE *fp, const char *name, Train **trains, char direction, int priority) {
+    double *waits = malloc((total_trains + 1) * sizeof(double));
+    int counts[NUM_WAIT_BUCKETS + 1] = {0};
+    int n = 0;
+    for (int i = 0; i < total_trains; i++) {
+        Train *t = trains[i];
+        if ((direction != '\0' && t->direction != direction) ||
+            (priority != -1 && t->priority != priority))
+            continue;
+        double wait = t->on_time - t->ready_time;
+        size_t b = 0;
+        while (b < NUM_WAIT_BUCKETS && wait > wait_buckets[b])
+            b++;
+        counts[b]++;
+        waits[n++] = wait;
+    }
+    fprintf(fp, "\"%s\":{", name);
+    write_distribution(fp, waits, n);
+    fprintf(fp, ",\"buckets\":[");
+    for (size_t b = 0; b < NUM_WAIT_BUCKETS; b++)
+        fprintf(fp, "%s%g", b ? "," : "", wait_buckets[b]);
+    fprintf(fp, "],\"counts\":[");
+    for (size_t b = 0; b <= NUM_WAIT_BUCKETS; b++)
+        fprintf(fp, "%s%d", b ? "," : "", counts[b]);
+    fprintf(fp, "]}");
+    free(waits);
+}
+
+// Writes a one-line snapshot of the run so far. Caller must hold the mutex.
+void write_periodic_report() {
+    double elapsed = get_elapsed_time();
+    double busy = busy_time;
+    if (on_track != NULL)
+        busy += elapsed - on_track->on_time; // include the crossing in progress
+    fprintf(metrics_fp, "{\"type\":\"periodic\",\"elapsed\":%.6f,\"waiting\":%d,"
+            "\"finished\":%d,\"track_in_use\":%d,\"busy_time\":%.6f,"
+            "\"utilization\":%.6f,\"direction_switches\":%d,"
+            "\"starvation_activations\":%d,\"decisions\":%d}\n",
+            elapsed, waiting_count, finished_count, track_in_use, busy,
+            elapsed > 0 ? busy / elapsed : 0, direction_switches,
+            starvation_activations, decision_count);
+    fflush(metrics_fp);
+}
+
+// Writes the end of run report as a single line of JSON.
+void write_final_report(Train **trains) {
+    FILE *fp = metrics_fp;
+    double makespan = 0;
+    for (int i = 0; i < total_trains; i++)
+        if (trains[i]->off_time > makespan)
+            makespan = trains[i]->off_time;
+
+    // idle gaps between one train leaving the track and the next one getting on
+    Train **by_on = malloc((total_trains + 1) * sizeof(Train *));
+    memcpy(by_on, trains, total_trains * sizeof(Train *));
+    qsort(by_on, total_trains, sizeof(Train *), compare_on_time);
+    int gap_count = 0;
+    double gap_total = 0, gap_max = 0;
+    for (int i = 1; i < total_trains; i++) {
+        double gap = by_on[i]->on_time - by_on[i - 1]->off_time;
+        if (gap < 0)
+            gap = 0;
+        gap_count++;
+        gap_total += gap;
+        if (gap > gap_max)
+            gap_max = gap;
+    }
+    free(by_on);
+
+    fprintf(fp, "{\"type\":\"final\",\"policy\":\"%s\",\"trains\":%d,\"makespan\":%.6f,"
+            "\"throughput\":%.6f,\"wait\":{", policy->name, total_trains, makespan,
+            makespan > 0 ? total_trains / makespan : 0);
+    write_wait_stats(fp, "all", trains, '\0', -1);
+    fputc(',', fp);
+    write_wait_stats(fp, "east", trains, 'E', -1);
+    fputc(',', fp);
+    write_wait_stats(fp, "west", trains, 'W', -1);
+    fputc(',', fp);
+    write_wait_stats(fp, "high", trains, '\0', 1);
+    fputc(',', fp);
+    write_wait_stats(fp, "low", trains, '\0', 0);
+    fputc(',', fp);
+    write_wait_stats(fp, "east_high", trains, 'E', 1);
+    fputc(',', fp);
+    write_wait_stats(fp, "east_low", trains, 'E', 0);
+    fputc(',', fp);
+    write_wait_stats(fp, "west_high", trains, 'W', 1);
+    fputc(',', fp);
+    write_wait_stats(fp, "west_low", trains, 'W', 0);
+    fprintf(fp, "},\"track\":{\"busy_time\":%.6f,\"utilization\":%.6f,"
+            "\"idle_gaps\":{\"count\":%d,\"total\":%.6f,\"mean\":%.6f,\"max\":%.6f}},"
+            "\"direction_switches\":%d,\"starvation_activations\":%d,"
+            "\"decision_latency_us\":{",
+            busy_time, makespan > 0 ? busy_time / makespan : 0, gap_count, gap_total,
+            gap_count ? gap_total / gap_count : 0, gap_max,
+            direction_switches, starvation_activations);
+    write_distribution(fp, decision_latency, decision_count);
+    fprintf(fp, "},\"per_train\":[");
+    for (int i = 0; i < total_trains; i++) {
+        Train *t = trains[i];
+        fprintf(fp, "%s{\"id\":%d,\"direction\":\"%c\",\"priority\":%d,"
+                "\"ready\":%.6f,\"on\":%.6f,\"off\":%.6f,\"wait\":%.6f}",
+                i ? "," : "", t->id, t->direction, t->priority, t->ready_time,
+                t->on_time, t->off_time, t->on_time - t->ready_time);
+    }
+    fprintf(fp, "]}\n");
+    fflush(fp);
+}
+
+// Metrics thread: emits a periodic report every report_interval simulated seconds.
+void *metrics_thread(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&mutex);
+    while (finished_count < total_trains) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        double real_interval = report_interval * time_unit / DEFAULT_TIME_UNIT;
+        long nsec = deadline.tv_nsec + (long)(real_interval * 1000000000.0);
+        deadline.tv_sec += nsec / 1000000000;
+        deadline.tv_nsec = nsec % 1000000000;
+        int rc = 0;
+        while (finished_count < total_trains && rc != ETIMEDOUT)
+            rc = pthread_cond_timedwait(&done_cond, &mutex, &deadline);
+        if (rc == ETIMEDOUT && finished_count < total_trains)
+            write_periodic_report();
+    }
+    pthread_mutex_unlock(&mutex);
+    return NULL;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-p policy] [-a aging_bound] [-u time_unit_usec] "
+            "[-m metrics_file] [-i report_interval] input_file\n", prog);
+    fprintf(stderr, "Policies:");
+    for (size_t i = 0; i < NUM_POLICIES; i++)
+        fprintf(stderr, " %s", policies[i].name);
+    fprintf(stderr, "\n");
+    exit(EXIT_FAILURE);
+}
+
+// Parses a whole finite decimal number, rejecting empty or trailing junk.
+double parse_double(const char *arg, const char *prog) {
+    char *end;
+    double value = strtod(arg, &end);
+    if (end == arg || *end != '\0' || !isfinite(value))
+        usage(prog);
+    return value;
+}
+
+// Parses a whole decimal integer, rejecting empty or trailing junk.
+int parse_int(const char *arg, const char *prog) {
+    char *end;
+    long value = strtol(arg, &end, 10);
+    if (end == arg || *end != '\0' || value < 0 || value > 1000000000)
+        usage(prog);
+    return (int)value;
+}
+
 int main(int argc, char *argv[]) {
-    if (argc != 2) {
-        fprintf(stderr, "Usage: %s input_file\n", argv[0]);
-        exit(EXIT_FAILURE);
+    const char *metrics_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:a:u:m:i:")) != -1) {
+        switch (opt) {
+        case 'p':
+            policy = NULL;
+            for (size_t i = 0; i < NUM_POLICIES; i++)
+                if (strcmp(optarg, policies[i].name) == 0)
+                    policy = &policies[i];
+            if (policy == NULL)
+                usage(argv[0]);
+            break;
+        case 'a':
+            aging_bound = parse_double(optarg, argv[0]);
+            if (aging_bound < 0)
+                usage(argv[0]);
+            break;
+        case 'u':
+            time_unit = parse_int(optarg, argv[0]);
+            if (time_unit <= 0)
+                usage(argv[0]);
+            break;
+        case 'm':
+            metrics_path = optarg;
+            break;
+        case 'i':
+            report_interval = parse_double(optarg, argv[0]);
+            if (report_interval <= 0)
+                usage(argv[0]);
+            break;
+        default:
+            usage(argv[0]);
+        }
     }
-    FILE *fp = fopen(argv[1], "r");
+    if (argc - optind != 1 || (report_interval > 0 && metrics_path == NULL))
+        usage(argv[0]);
+    FILE *fp = fopen(argv[optind], "r");
     if (!fp) {
         perror("Error opening input file");
         exit(EXIT_FAILURE);
     }
-    Train *trains[MAX_TRAINS];
+    Train **trains = NULL;
+    int capacity = 0;
     total_trains = 0;
     char dir_char;
     int load, cross;
     while (fscanf(fp, " %c %d %d", &dir_char, &load, &cross) == 3) {
-        if (total_trains >= MAX_TRAINS)
-            break;
+        if (total_trains == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            trains = realloc(trains, capacity * sizeof(Train *));
+            if (!trains) {
+                perror("Error allocating trains");
+                exit(EXIT_FAILURE);
+            }
+        }
         Train *t = malloc(sizeof(Train));
         t->id = total_trains;
         t->direction = (dir_char == 'e' || dir_char == 'E') ? 'E' : 'W';
@@ -245,22 +520,67 @@ int main(int argc, char *argv[]) {
     }
     fclose(fp);
     
+    if (metrics_path != NULL) {
+        metrics_fp = strcmp(metrics_path, "-") == 0 ? stdout : fopen(metrics_path, "w");
+        if (!metrics_fp) {
+            perror("Error opening metrics file");
+            exit(EXIT_FAILURE);
+        }
+    }
+    waiting_list = malloc((total_trains + 1) * sizeof(Train *));
+    decision_latency = malloc((total_trains + 1) * sizeof(double));
+    
     gettimeofday(&start_time, NULL); // record simulation start time
     pthread_t scheduler;
-    pthread_create(&scheduler, NULL, scheduler_thread, NULL); // create scheduler thread
+    if (pthread_create(&scheduler, NULL, scheduler_thread, NULL) != 0) { // create scheduler thread
+        fprintf(stderr, "Error creating scheduler thread\n");
+        exit(EXIT_FAILURE);
+    }
+    pthread_t reporter;
+    if (metrics_fp && report_interval > 0 &&
+        pthread_create(&reporter, NULL, metrics_thread, NULL) != 0) { // create metrics thread
+        fprintf(stderr, "Error creating metrics thread\n");
+        exit(EXIT_FAILURE);
+    }
     
-    pthread_t train_threads[MAX_TRAINS];
-    for (int i = 0; i < total_trains; i++)
-        pthread_create(&train_threads[i], NULL, train_thread, (void *)trains[i]); // create train threads
+    pthread_t *train_threads = malloc((total_trains + 1) * sizeof(pthread_t));
+    int loaded_trains = total_trains;
+    for (int i = 0; i < loaded_trains; i++) {
+        if (pthread_create(&train_threads[i], NULL, train_thread, (void *)trains[i]) != 0) {
+            // run with the trains already started so the scheduler can still finish
+            fprintf(stderr, "Error creating train thread, running only %d of %d trains\n",
+                    i, loaded_trains);
+            pthread_mutex_lock(&mutex);
+            total_trains = i;
+            pthread_cond_signal(&sched_cond);
+            if (finished_count == total_trains)
+                pthread_cond_signal(&done_cond);
+            pthread_mutex_unlock(&mutex);
+            break;
+        }
+    }
     
     for (int i = 0; i < total_trains; i++)
         pthread_join(train_threads[i], NULL); // wait for all train threads
     pthread_join(scheduler, NULL);              // wait for scheduler thread
+    if (metrics_fp && report_interval > 0)
+        pthread_join(reporter, NULL);
     
-    for (int i = 0; i < total_trains; i++) {
+    if (metrics_fp) {
+        fflush(stdout); // keep event lines ahead of the report when both go to stdout
+        write_final_report(trains);
+        if (metrics_fp != stdout)
+            fclose(metrics_fp);
+    }
+    free(decision_latency);
+    free(waiting_list);
+    free(train_threads);
+    
+    for (int i = 0; i < loaded_trains; i++) {
         pthread_cond_destroy(&trains[i]->cond);
         free(trains[i]);
     }
+    free(trains);
     
     return 0;
 }